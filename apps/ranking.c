@@ -1,4 +1,5 @@
 #include "regatta.h"
+#include "result.h"
 #include "sailor.h"
 #include <pthread.h>
 #include <stddef.h>
@@ -12,9 +13,12 @@ void* loadDoc(void* regatta) {
 }
 
 #define REGATTA_COUNT 3 // equals thread count
+#define DOC_BUDGET 2    // max docs live at once, 0 for unlimited
 
-int main() {
+int main(int argc, char* argv[]) {
   regattaPoolInit();
+  // optional first arg overrides the budget
+  regattaPoolSetDocBudget(argc > 1 ? (size_t)atoi(argv[1]) : DOC_BUDGET);
 
   char* urls[] = {
     // clang-format off
@@ -36,6 +40,11 @@ int main() {
     }
   }
 
+  // process data: single threaded because the business logic is order
+  // dependent. Each doc is freed once processed, unblocking the next fetch
+  for (int i = 0; i < REGATTA_COUNT; i++)
+    regattaLoad(regattaPoolWaitForDoc(i));
+
   // wait for threads to finish
   for (int i = 0; i < REGATTA_COUNT; i++) {
     void* status;
@@ -46,12 +55,9 @@ int main() {
     }
   }
 
-  // process data: single threaded because the business logic is order dependent
-  for (int i = 0; i < REGATTA_COUNT; i++)
-    regattaLoad(regattaPoolFindByIndex(i));
-
   // and display it
-  fprintf(stderr, "%zu Sailors\n", sailorPoolGetUsed());
+  fprintf(stderr, "%zu Sailors, %zu Results\n", sailorPoolGetUsed(),
+          resultPoolGetUsed());
   for (size_t i = 0; i < sailorPoolGetUsed(); i++) {
     Sailor* sailor = sailorPoolGet(i);
     fprintf(stdout, "#%-3d %5i %-30s %-1s %3d %-30.30s\n", sailor->id,
@@ -59,6 +65,9 @@ int main() {
             sailor->club);
   }
 
+  regattaPoolPrintStats();
+
+  resultPoolFree();
   sailorPoolFree();
   regattaPoolFree();
   return EXIT_SUCCESS;
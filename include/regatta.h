@@ -3,14 +3,21 @@
 
 #include <libxml/HTMLparser.h>
 #include <libxml/xpath.h>
+#include <stdbool.h>
 
 typedef struct Regatta {
   int       id;
   char*     url;
   xmlDocPtr doc;
+  size_t    seq;    // position in pool, which is also the processing order
+  size_t    bytes;  // size of the raw html the doc was parsed from
+  bool      loaded; // fetch attempted, doc is valid or NULL on failure
 } Regatta;
 
 void     regattaPoolInit(void);
+void     regattaPoolSetDocBudget(size_t max_docs);
+Regatta* regattaPoolWaitForDoc(int i);
+void     regattaPoolPrintStats(void);
 Regatta* regattaPoolAdd(Regatta* regatta);
 Regatta* regattaNew(int id, char* url);
 Regatta* regattaPoolFindByIndex(int i);
@@ -0,0 +1,34 @@
+#ifndef __RESULT_H__
+#define __RESULT_H__
+
+#include "sailor.h"
+#include <sys/types.h>
+
+// one observation of a sailor in a regatta, as it appeared in the row
+typedef struct Result {
+  int                sailor_id;
+  int                regatta_id;
+  unsigned int       sailno;
+  unsigned int       rank;
+  char*              club;
+  char               gender; // first letter, '\0' if not given
+  unsigned short int age;
+} Result;
+
+Result* resultPoolAdd(Result* result);
+Result* resultPoolGet(int i);
+size_t  resultPoolGetUsed(void);
+void    resultPoolFree(void);
+
+Result** resultPoolFindBySailor(int sailor_id, size_t* count);
+Result** resultPoolFindByRegatta(int regatta_id, size_t* count);
+Result*  resultPoolFindBySailorAndRegatta(int sailor_id, int regatta_id);
+
+size_t resultHeadToHead(int sailor_id_a, int sailor_id_b, size_t* a_ahead,
+                        size_t* b_ahead);
+size_t resultCountByClub(int regatta_id, const char* club);
+
+Result* resultNewFromSailor(int regatta_id, Sailor* observed);
+void    resultFree(Result* result);
+
+#endif /* __RESULT_H__ */
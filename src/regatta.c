@@ -1,6 +1,7 @@
 #include "regatta.h"
 #include "curl.h"
 #include "easylib.h"
+#include "result.h"
 #include "sailor.h"
 #include <curl/curl.h>
 #include <libgen.h> // basename
@@ -9,19 +10,35 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h> // getrusage
 
 typedef struct RegattaPool {
   Regatta** regattas;
   size_t    count;
   size_t    size;
+
+  // memory budget: at most `budget` docs (or their raw buffers) are live at
+  // once, 0 for unlimited. Slots are granted in pool order and released
+  // as regattaLoad finishes with each doc, so fetching cannot deadlock
+  // against the in-order processing
+  size_t budget;
+  size_t released;
+
+  // per stage accounting, for regattaPoolPrintStats
+  size_t live_docs;
+  size_t peak_docs;
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t fetched_bytes;
 } RegattaPool;
 
 // just a single private instance of the pool
 static RegattaPool         pool = {0};
 static pthread_mutex_t     mut;
 static pthread_mutexattr_t mut_attr;
+static pthread_cond_t      cond; // signals doc loaded or doc released
 
-xmlDocPtr     getDoc(char* url);
+xmlDocPtr     getDoc(char* url, size_t* bytes);
 xmlNodeSetPtr getXpathNodeSet(char* xpath, xmlXPathContextPtr ctx);
 xmlNodeSetPtr getXpathNodeSetRel(char* xpath, xmlNodePtr relnode,
                                  xmlXPathContextPtr ctx);
@@ -38,6 +55,14 @@ void regattaPoolInit() {
   pthread_mutexattr_init(&mut_attr);
   pthread_mutexattr_settype(&mut_attr, PTHREAD_MUTEX_RECURSIVE);
   pthread_mutex_init(&mut, &mut_attr);
+  pthread_cond_init(&cond, NULL);
+}
+
+// call before any docs are loaded
+void regattaPoolSetDocBudget(size_t max_docs) {
+  pthread_mutex_lock(&mut);
+  pool.budget = max_docs;
+  pthread_mutex_unlock(&mut);
 }
 
 void regattaPoolFree() {
@@ -48,6 +73,7 @@ void regattaPoolFree() {
   free(pool.regattas); // and the array of pointers to those objects
   pool = (RegattaPool){0};
   pthread_mutex_unlock(&mut);
+  pthread_cond_destroy(&cond);
   pthread_mutex_destroy(&mut);
   pthread_mutexattr_destroy(&mut_attr);
 
@@ -70,6 +96,7 @@ Regatta* regattaPoolAdd(Regatta* regatta) {
     }
     pool.regattas = t_regattas;
   }
+  regatta->seq                = pool.count;
   pool.regattas[pool.count++] = regatta;
   pthread_mutex_unlock(&mut);
   return regatta;
@@ -94,6 +121,53 @@ void regattaFree(Regatta* regatta) {
 
 Regatta* regattaPoolFindByIndex(int i) { return pool.regattas[i]; }
 
+// blocks until the fetch worker for regatta `i` has finished
+Regatta* regattaPoolWaitForDoc(int i) {
+  pthread_mutex_lock(&mut);
+  Regatta* regatta = pool.regattas[i];
+  while (!regatta->loaded) pthread_cond_wait(&cond, &mut);
+  pthread_mutex_unlock(&mut);
+  return regatta;
+}
+
+void regattaPoolPrintStats() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  pthread_mutex_lock(&mut);
+  fprintf(stderr, "fetch: %zu bytes of html from %zu regattas\n",
+          pool.fetched_bytes, pool.count);
+  fprintf(stderr, "parse: peak %zu docs live from %zu bytes of html",
+          pool.peak_docs, pool.peak_bytes);
+  if (pool.budget)
+    fprintf(stderr, " (budget %zu docs)\n", pool.budget);
+  else
+    fprintf(stderr, " (no budget)\n");
+  pthread_mutex_unlock(&mut);
+#ifdef __APPLE__
+  usage.ru_maxrss /= 1024; // bytes on macOS, kilobytes elsewhere
+#endif
+  fprintf(stderr, "peak RSS: %ld kB\n", usage.ru_maxrss);
+}
+
+// wait for a slot within the budget, before any memory is allocated
+static void regattaAcquireDocSlot(Regatta* regatta) {
+  pthread_mutex_lock(&mut);
+  while (pool.budget && regatta->seq >= pool.released + pool.budget)
+    pthread_cond_wait(&cond, &mut);
+  if (++pool.live_docs > pool.peak_docs) pool.peak_docs = pool.live_docs;
+  pthread_mutex_unlock(&mut);
+}
+
+static void regattaReleaseDocSlot(Regatta* regatta) {
+  pthread_mutex_lock(&mut);
+  pool.live_docs--;
+  pool.live_bytes -= regatta->bytes;
+  pool.released++;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mut);
+}
+
 #define MAX_FIELDS 25
 
 typedef enum {
@@ -106,79 +180,143 @@ typedef enum {
   CLUB,
 } StdField;
 
-typedef Sailor* (*setter_t)(Sailor*, char*);
-
 typedef struct FieldMapItem {
   StdField std;
-  int      cust;
   char*    pattern;
-  setter_t setter;
 } FieldMapItem;
 
 const FieldMapItem pattern_fmis[] = {
     // clang-format off
-    // std enum      cust   pattern             &setter_func_ptr
-    {  HELM,         NAF,   "Helm",             &sailorSetName},
-    {  SAILNO,       NAF,   "Sailno",           &sailorSetSailnoString},
-    {  RANK,         NAF,   "rank|seriesplace", &sailorSetRankString},
-    {  GENDER,       NAF,   "M/F",              &sailorSetGender},
-    {  AGE,          NAF,   "Age",              &sailorSetAgeString},
-    {  CLUB,         NAF,   "Club",             &sailorSetClub},
-    {  NAF,          NAF,   "",                 NULL}, // End of list terminator
+    // std enum      pattern
+    {  HELM,         "Helm"},
+    {  SAILNO,       "Sailno"},
+    {  RANK,         "rank|seriesplace"},
+    {  GENDER,       "M/F"},
+    {  AGE,          "Age"},
+    {  CLUB,         "Club"},
+    {  NAF,          ""}, // End of list terminator
     // clang-format on
 };
 
+// resolved once per table from the header row: a column -> field plan, so
+// each data row is decoded by walking only the mapped columns
 typedef struct FieldMap {
-  FieldMapItem items[MAX_FIELDS];
+  StdField cols[MAX_FIELDS]; // std field for each column, NAF if unmapped
+  int      cust[MAX_FIELDS]; // column for each std field, NAF if unmapped
+  int      ncols;            // one past the last mapped column
 } FieldMap;
 
-typedef char* ResultRow[MAX_FIELDS];
-
 FieldMap* regattaNewFieldMap() {
   FieldMap* fm = malloc(sizeof *fm);
   if (!fm) {
     perror("malloc FieldMap");
     exit(EXIT_FAILURE);
   }
-  for (int std = 0; std < MAX_FIELDS; std++)
-    fm->items[std] = (FieldMapItem){std, NAF, NULL, NULL};
+  for (int i = 0; i < MAX_FIELDS; i++) fm->cols[i] = fm->cust[i] = NAF;
+  fm->ncols = 0;
   return fm;
 }
 
 FieldMap* regattaMakeFieldMap(xmlNodeSetPtr header_cells) {
   FieldMap* fm = regattaNewFieldMap();
-  char*     val;
-  for (int cell = 0; cell < header_cells->nodeNr; cell++) {
-    val = (char*)xmlNodeGetContent(header_cells->nodeTab[cell]);
+  int       ncells = header_cells->nodeNr;
+  for (int cell = 0; cell < ncells && cell < MAX_FIELDS; cell++) {
+    char* val         = (char*)xmlNodeGetContent(header_cells->nodeTab[cell]);
+    char* trimmed_val = remove_spaces(val);
     for (int p = 0; pattern_fmis[p].std != NAF; p++) {
-      char* trimmed_val = remove_spaces(val);
-      bool matched = preg_match(pattern_fmis[p].pattern, trimmed_val, true);
-      free(trimmed_val);
-      if (matched) {
-        fm->items[pattern_fmis[p].std] =
-            pattern_fmis[p]; // copy FieldMapItem (shallow copy)
-        fm->items[pattern_fmis[p].std].cust = cell; // record matching mapping
+      if (preg_match(pattern_fmis[p].pattern, trimmed_val, true)) {
+        StdField std = pattern_fmis[p].std;
+        // last matching column wins, as each field is decoded only once
+        if (fm->cust[std] != NAF) fm->cols[fm->cust[std]] = NAF;
+        fm->cust[std]  = cell;
+        fm->cols[cell] = std;
+        fm->ncols      = cell + 1;
         break;
       }
     }
+    free(trimmed_val);
     free(val);
   }
   return fm;
 }
 
-Sailor* regattaBuildSailorFromMappedRow(ResultRow row, FieldMap* fm) {
+// numeric cells are nearly always a single text node: parse that in place
+// and only fall back to building the concatenated content for nested markup
+static unsigned int regattaCellToUInt(xmlNodePtr cell) {
+  xmlNodePtr child = cell->children;
+  if (child && !child->next && child->type == XML_TEXT_NODE)
+    return atoi((char*)child->content);
+
+  char*        val = (char*)xmlNodeGetContent(cell);
+  unsigned int num = val ? atoi(val) : 0;
+  free(val);
+  return num;
+}
+
+// string cells: the content is allocated by libxml2 anyway, so the sailor
+// takes ownership of it rather than receiving a further copy
+static char* regattaCellToString(xmlNodePtr cell) {
+  return (char*)xmlNodeGetContent(cell);
+}
+
+static void regattaDecodeCell(Sailor* sailor, StdField std, xmlNodePtr cell) {
+  switch (std) {
+  case HELM:
+    sailor->name = regattaCellToString(cell);
+    break;
+  case SAILNO:
+    sailor->sailno = regattaCellToUInt(cell);
+    break;
+  case RANK:
+    sailor->rank = regattaCellToUInt(cell);
+    break;
+  case GENDER:
+    sailor->gender = regattaCellToString(cell);
+    if (sailor->gender && *sailor->gender)
+      sailor->gender[1] = '\0'; // just first letter
+    break;
+  case AGE:
+    sailor->age = regattaCellToUInt(cell);
+    break;
+  case CLUB:
+    sailor->club = regattaCellToString(cell);
+    break;
+  case NAF:
+    break;
+  }
+}
+
+Sailor* regattaBuildSailorFromMappedRow(xmlNodeSetPtr cells, FieldMap* fm) {
   Sailor* sailor = sailorNewNoPool();
-  for (int std = 0; std < MAX_FIELDS && fm->items[std].cust != NAF; std++)
-    // use func_ptr "setter" to update the sailor with the mapped values
-    (fm->items[std].setter)(sailor, row[fm->items[std].cust]);
+  for (int col = 0; col < cells->nodeNr && col < fm->ncols; col++)
+    if (fm->cols[col] != NAF)
+      regattaDecodeCell(sailor, fm->cols[col], cells->nodeTab[col]);
   return sailor;
 }
 
 void regattaLoadDoc(Regatta* regatta) {
-  regatta->doc = getDoc(regatta->url);
+  regattaAcquireDocSlot(regatta);
+  size_t    bytes = 0;
+  xmlDocPtr doc   = getDoc(regatta->url, &bytes);
+
+  pthread_mutex_lock(&mut);
+  regatta->doc    = doc;
+  regatta->bytes  = bytes;
+  regatta->loaded = true;
+
+  pool.fetched_bytes += bytes;
+  pool.live_bytes += bytes;
+  if (pool.live_bytes > pool.peak_bytes) pool.peak_bytes = pool.live_bytes;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mut);
 }
 
+// processes and then frees the doc, releasing its slot in the budget
 void regattaLoad(Regatta* regatta) {
+  if (!regatta->doc) {
+    regattaReleaseDocSlot(regatta); // fetch failed, nothing to process
+    return;
+  }
   xmlXPathContextPtr ctx = xmlXPathNewContext(regatta->doc);
 
   xmlNodeSetPtr tables = getXpathNodeSet("//table[@border=1]", ctx);
@@ -196,19 +334,12 @@ void regattaLoad(Regatta* regatta) {
       // cells of the current row
       xmlNodeSetPtr cells =
           getXpathNodeSetRel(".//td", rows->nodeTab[row], ctx);
-      ResultRow row_vals = {0};
-      for (int col = 0; col < cells->nodeNr && col < MAX_FIELDS; col++) {
-        // build a whole row. Sometimes cross cell validation / fixing occurs
-        row_vals[col] = (char*)xmlNodeGetContent(cells->nodeTab[col]);
-      }
-
-      Sailor* sailor = regattaBuildSailorFromMappedRow(row_vals, fm);
+      Sailor* sailor = regattaBuildSailorFromMappedRow(cells, fm);
+      // log the row as observed, before the example is merged into the pool
+      Result* result = resultNewFromSailor(regatta->id, sailor);
       // example free'd inside call, or added to pool.
-      sailorPoolFindByExampleOrNew(sailor);
-
-      // cleanup strings created
-      for (int col = 0; col < cells->nodeNr && col < MAX_FIELDS; col++)
-        free(row_vals[col]);
+      result->sailor_id = sailorPoolFindByExampleOrNew(sailor)->id;
+      resultPoolAdd(result);
 
       xmlXPathFreeNodeSet(cells);
     }
@@ -220,16 +351,19 @@ void regattaLoad(Regatta* regatta) {
   xmlXPathFreeContext(ctx);
   xmlFreeDoc(regatta->doc);
   regatta->doc = NULL;
+  regattaReleaseDocSlot(regatta);
 }
 
-xmlDocPtr getDoc(char* url) {
+xmlDocPtr getDoc(char* url, size_t* bytes) {
   Buffer buffer = (Buffer){0}; // ptr set by realloc
 
   // Can't just call libxml->htmlParseFile, not thread safe. Use curl
   if (curl_load_url(url, &buffer)) {
     fprintf(stderr, "Document not loaded successfully. \n");
+    free(buffer.mem);
     return NULL;
   }
+  *bytes = buffer.size;
   // htmlReadMemory needs this for relative urls within the html document
   // take copy, not guaranted to persist
   char*     base = strdup(dirname(url));
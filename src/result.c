@@ -0,0 +1,165 @@
+#include "result.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// posting list: the results for one sailor or one regatta, in log order
+typedef struct Postings {
+  Result** results;
+  size_t   count;
+  size_t   size;
+} Postings;
+
+typedef struct ResultPool {
+  Result** results; // append only log
+  size_t   count;
+  size_t   size;
+
+  Postings* by_sailor; // indexed by sailor id
+  size_t    by_sailor_size;
+  Postings* by_regatta; // indexed by regatta id
+  size_t    by_regatta_size;
+} ResultPool;
+
+// just a single private instance of the pool
+static ResultPool pool = {0};
+
+static void* resultRealloc(void* ptr, size_t req_bytes) {
+  void* t_ptr = realloc(ptr, req_bytes);
+  if (!t_ptr) {
+    fprintf(stderr, "realloc failed to allocate bytes = %zu\n", req_bytes);
+    free(ptr);
+    exit(EXIT_FAILURE);
+  }
+  return t_ptr;
+}
+
+static void postingsAdd(Postings* postings, Result* result) {
+  if (postings->count == postings->size) {
+    postings->size    = 3 * postings->size / 2 + 8;
+    postings->results = resultRealloc(
+        postings->results, postings->size * sizeof *postings->results);
+  }
+  postings->results[postings->count++] = result;
+}
+
+// grow an index so `id` is a valid slot, new slots are empty posting lists
+static Postings* postingsIndexGet(Postings** index, size_t* size, int id) {
+  if ((size_t)id >= *size) {
+    size_t new_size = 3 * (size_t)id / 2 + 8;
+    *index          = resultRealloc(*index, new_size * sizeof **index);
+    memset(*index + *size, 0, (new_size - *size) * sizeof **index);
+    *size = new_size;
+  }
+  return &(*index)[id];
+}
+
+static Result** postingsIndexFind(Postings* index, size_t size, int id,
+                                  size_t* count) {
+  if (id < 0 || (size_t)id >= size) {
+    *count = 0;
+    return NULL;
+  }
+  *count = index[id].count;
+  return index[id].results;
+}
+
+Result* resultPoolAdd(Result* result) {
+  if (pool.count == pool.size) {
+    pool.size    = 3 * pool.size / 2 + 8;
+    pool.results =
+        resultRealloc(pool.results, pool.size * sizeof *pool.results);
+  }
+  pool.results[pool.count++] = result;
+
+  postingsAdd(postingsIndexGet(&pool.by_sailor, &pool.by_sailor_size,
+                               result->sailor_id),
+              result);
+  postingsAdd(postingsIndexGet(&pool.by_regatta, &pool.by_regatta_size,
+                               result->regatta_id),
+              result);
+  return result;
+}
+
+Result* resultPoolGet(int i) { return pool.results[i]; }
+
+size_t resultPoolGetUsed(void) { return pool.count; }
+
+void resultPoolFree(void) {
+  for (size_t i = 0; i < pool.by_sailor_size; i++)
+    free(pool.by_sailor[i].results);
+  for (size_t i = 0; i < pool.by_regatta_size; i++)
+    free(pool.by_regatta[i].results);
+  free(pool.by_sailor);
+  free(pool.by_regatta);
+
+  for (size_t i = 0; i < pool.count; i++) resultFree(pool.results[i]);
+  free(pool.results);
+  pool = (ResultPool){0};
+}
+
+Result** resultPoolFindBySailor(int sailor_id, size_t* count) {
+  return postingsIndexFind(pool.by_sailor, pool.by_sailor_size, sailor_id,
+                           count);
+}
+
+Result** resultPoolFindByRegatta(int regatta_id, size_t* count) {
+  return postingsIndexFind(pool.by_regatta, pool.by_regatta_size, regatta_id,
+                           count);
+}
+
+Result* resultPoolFindBySailorAndRegatta(int sailor_id, int regatta_id) {
+  size_t   count;
+  Result** results = resultPoolFindBySailor(sailor_id, &count);
+  for (size_t i = 0; i < count; i++)
+    if (results[i]->regatta_id == regatta_id) return results[i];
+  return NULL;
+}
+
+// returns the number of regattas both sailors were ranked in, and how often
+// each finished ahead of the other. Rank 0 means unranked
+size_t resultHeadToHead(int sailor_id_a, int sailor_id_b, size_t* a_ahead,
+                        size_t* b_ahead) {
+  size_t   shared = 0, count;
+  Result** results = resultPoolFindBySailor(sailor_id_a, &count);
+  *a_ahead = *b_ahead = 0;
+  for (size_t i = 0; i < count; i++) {
+    Result* a = results[i];
+    Result* b = resultPoolFindBySailorAndRegatta(sailor_id_b, a->regatta_id);
+    if (!b || !a->rank || !b->rank) continue;
+    shared++;
+    if (a->rank < b->rank) (*a_ahead)++;
+    if (b->rank < a->rank) (*b_ahead)++;
+  }
+  return shared;
+}
+
+size_t resultCountByClub(int regatta_id, const char* club) {
+  size_t   matched = 0, count;
+  Result** results = resultPoolFindByRegatta(regatta_id, &count);
+  for (size_t i = 0; i < count; i++)
+    if (results[i]->club && strcasecmp(results[i]->club, club) == 0) matched++;
+  return matched;
+}
+
+// copies the row data, the sailor_id is set once the sailor is pooled
+Result* resultNewFromSailor(int regatta_id, Sailor* observed) {
+  Result* result = calloc(1, sizeof *result);
+  if (!result) {
+    perror("calloc result");
+    exit(EXIT_FAILURE);
+  }
+  result->regatta_id = regatta_id;
+  result->sailno     = observed->sailno;
+  result->rank       = observed->rank;
+  result->age        = observed->age;
+  if (observed->club) result->club = strdup(observed->club);
+  if (observed->gender) result->gender = observed->gender[0];
+  return result;
+}
+
+void resultFree(Result* result) {
+  if (result) free(result->club);
+  free(result);
+}
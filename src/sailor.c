@@ -87,8 +87,8 @@ Sailor* sailorPoolFindByExampleOrNew(Sailor* new) {
   return sailor;
 }
 
-// need all the below setters, because used as function pointers
-// in the field map
+// setters for building sailors outside of the regatta row decoder, which
+// writes the fields directly
 Sailor* sailorSetName(Sailor* sailor, char* name) {
   sailor->name = strdup(name);
   return sailor;